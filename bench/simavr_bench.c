@@ -0,0 +1,687 @@
+// simavr_bench.c
+//
+// Cycle-accurate benchmark harness for the CatScarer AVR firmware.
+// Runs firmware.elf under simavr, drives the PIR (D2) and IR receiver (D4)
+// pins from a scenario script, and writes the results as JSON:
+//   - cycles per call of each profiled function (loop(), component updates, ISRs),
+//     excluding interrupts that fired during the call (reported as isr_cycles)
+//   - motion-to-fan latency: PIR rising edge -> fan pin (D9) driven
+//   - flash and static SRAM usage of the image
+// The firmware's serial output is checked against the scenario's expected
+// state transitions; a mismatch makes the run fail with exit status 3.
+//
+// Normally run through bench/simavr_bench.py, which builds the firmware,
+// looks up function addresses and merges the results.
+//
+// Usage:
+//   simavr_bench --firmware firmware.elf --scenario scenario.txt --json out.json
+//                [--func name=0xADDR ...] [--mcu atmega328p] [--freq 16000000]
+//                [--uart-log uart.txt]
+//
+// Scenario lines are "<time_ms> <action> [arg]", '#' starts a comment:
+//   pir 1 | pir 0     drive the PIR output high/low
+//   ir 0x45           send an NEC frame (address 0x00) with this command
+//   mark <name>       start a new reporting phase
+//   expect <text>     a serial line containing <text> must be printed after the
+//                     previous expect matched and no later than time_ms
+//   forbid <text>     no serial line may contain <text> from time_ms until the next mark
+//   end               stop the simulation
+//
+// Exit status: 0 ok, 1 firmware crashed, 2 usage/setup error, 3 UART check failed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_io.h"
+#include "avr_ioport.h"
+#include "avr_timer.h"
+#include "avr_uart.h"
+
+#define MAX_FUNCS   16
+#define MAX_PHASES  16
+#define MAX_EVENTS  4096
+#define MAX_DEPTH   32
+#define MAX_CHECKS  128
+#define MAX_TEXT    64
+#define MAX_LINE    128
+
+// ATmega328P stack pointer in data space
+#define SPL_ADDR 0x5D
+#define SPH_ADDR 0x5E
+
+// Board wiring (see src/main.cpp)
+#define PIR_PORT 'D'
+#define PIR_BIT  2
+#define IR_PORT  'D'
+#define IR_BIT   4
+#define FAN_PORT 'B'
+#define FAN_BIT  1
+
+// ATmega328P interrupt vector table: 26 vectors x 4 bytes. The CPU lands in
+// it (past the reset vector) only when an interrupt is taken.
+#define VECTOR_TABLE_BYTES 0x68
+
+typedef struct {
+    uint64_t calls;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    uint64_t isr;        // Interrupt cycles left out of total
+} func_stats_t;
+
+typedef struct {
+    char name[32];
+    func_stats_t stats[MAX_FUNCS];
+} phase_t;
+
+typedef struct {
+    char name[64];
+    uint32_t addr;
+} func_t;
+
+typedef struct {
+    int func;            // -1: interrupt entry (any vector, profiled or not)
+    uint64_t start;
+    uint16_t sp;
+    uint64_t isr;        // Cycles spent in interrupts nested inside this frame
+} frame_t;
+
+enum { EV_PIN, EV_MARK, EV_END };
+
+typedef struct {
+    uint64_t cycle;
+    int kind;
+    char port;
+    int bit;
+    int value;
+    char label[32];
+} event_t;
+
+// Expected or forbidden serial output
+typedef struct {
+    uint64_t cycle;      // expect: deadline, forbid: start
+    uint64_t until;      // forbid: end (next mark)
+    int forbid;
+    int line_no;         // Scenario line, for error messages
+    char text[MAX_TEXT];
+} check_t;
+
+static func_t funcs[MAX_FUNCS];
+static int func_count = 0;
+
+static phase_t phases[MAX_PHASES];
+static int phase_count = 0;
+
+static frame_t frames[MAX_DEPTH];
+static int depth = 0;
+
+static event_t events[MAX_EVENTS];
+static int event_count = 0;
+
+static check_t expects[MAX_CHECKS];
+static int expect_count = 0;
+static int next_expect = 0;
+static check_t forbids[MAX_CHECKS];
+static int forbid_count = 0;
+static int check_failed = 0;
+
+// Serial line being received
+static char uart_line[MAX_LINE];
+static int uart_len = 0;
+static char last_line[MAX_LINE];
+
+static avr_t* avr = NULL;
+static uint32_t freq = 16000000;
+static FILE* uart_log = NULL;
+
+// Motion-to-fan latency tracking
+static int fan_on = 0;
+static int motion_pending = 0;
+static uint64_t motion_cycle = 0;
+static uint64_t lat_samples = 0, lat_ignored = 0, lat_total = 0, lat_min = UINT64_MAX, lat_max = 0;
+
+static uint64_t ms_to_cycles(double ms) {
+    return (uint64_t)(ms * (freq / 1000.0) + 0.5);
+}
+
+static double cycles_to_us(uint64_t cycles) {
+    return cycles * 1000000.0 / freq;
+}
+
+static double cycles_to_ms(uint64_t cycles) {
+    return cycles * 1000.0 / freq;
+}
+
+static void add_event(const event_t* ev) {
+    if (event_count >= MAX_EVENTS) {
+        fprintf(stderr, "simavr_bench: too many scenario events (max %d)\n", MAX_EVENTS);
+        exit(2);
+    }
+    events[event_count++] = *ev;
+}
+
+static void add_pin_event(uint64_t cycle, char port, int bit, int value) {
+    event_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.cycle = cycle;
+    ev.kind = EV_PIN;
+    ev.port = port;
+    ev.bit = bit;
+    ev.value = value;
+    add_event(&ev);
+}
+
+// NEC frame as seen on a TSOP output (idle HIGH, mark = LOW), LSB first
+static void add_nec_frame(uint64_t start, uint8_t address, uint8_t command) {
+    const double unit_us = 562.5;
+    uint32_t data = address | ((uint32_t)(uint8_t)~address << 8) |
+                    ((uint32_t)command << 16) | ((uint32_t)(uint8_t)~command << 24);
+    double t_us = 0;
+
+    add_pin_event(start, IR_PORT, IR_BIT, 0);              // 9ms leading mark
+    t_us += 16 * unit_us;
+    add_pin_event(start + ms_to_cycles(t_us / 1000.0), IR_PORT, IR_BIT, 1); // 4.5ms space
+    t_us += 8 * unit_us;
+
+    for (int i = 0; i < 32; i++) {
+        add_pin_event(start + ms_to_cycles(t_us / 1000.0), IR_PORT, IR_BIT, 0);
+        t_us += unit_us;
+        add_pin_event(start + ms_to_cycles(t_us / 1000.0), IR_PORT, IR_BIT, 1);
+        t_us += ((data >> i) & 1) ? 3 * unit_us : unit_us;
+    }
+
+    add_pin_event(start + ms_to_cycles(t_us / 1000.0), IR_PORT, IR_BIT, 0); // Stop bit
+    t_us += unit_us;
+    add_pin_event(start + ms_to_cycles(t_us / 1000.0), IR_PORT, IR_BIT, 1);
+}
+
+static void add_check(uint64_t cycle, int forbid, const char* text, int line_no) {
+    check_t* c;
+    if (forbid) {
+        c = forbid_count < MAX_CHECKS ? &forbids[forbid_count++] : NULL;
+    } else {
+        c = expect_count < MAX_CHECKS ? &expects[expect_count++] : NULL;
+    }
+    if (!c) {
+        fprintf(stderr, "simavr_bench: too many expect/forbid lines (max %d each)\n", MAX_CHECKS);
+        exit(2);
+    }
+    memset(c, 0, sizeof(*c));
+    c->cycle = cycle;
+    c->until = UINT64_MAX;
+    c->forbid = forbid;
+    c->line_no = line_no;
+    strncpy(c->text, text, sizeof(c->text) - 1);
+}
+
+static int compare_events(const void* a, const void* b) {
+    const event_t* ea = (const event_t*)a;
+    const event_t* eb = (const event_t*)b;
+    if (ea->cycle != eb->cycle) {
+        return ea->cycle < eb->cycle ? -1 : 1;
+    }
+    return 0;
+}
+
+static void load_scenario(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        exit(2);
+    }
+
+    char line[256];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        char* hash = strchr(line, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+
+        double ms;
+        char action[32] = "", arg[32] = "";
+        int rest = 0;
+        int n = sscanf(line, "%lf %31s %n", &ms, action, &rest);
+        if (n <= 0) {
+            continue; // Blank or comment
+        }
+        if (n < 2) {
+            fprintf(stderr, "%s:%d: expected '<time_ms> <action>'\n", path, line_no);
+            exit(2);
+        }
+
+        // expect/forbid take the rest of the line as text
+        char* text = rest ? line + rest : line + strlen(line);
+        size_t len = strlen(text);
+        while (len > 0 && (text[len - 1] == '\n' || text[len - 1] == '\r' ||
+                           text[len - 1] == ' ' || text[len - 1] == '\t')) {
+            text[--len] = '\0';
+        }
+        if (sscanf(text, "%31s", arg) == 1) {
+            n = 3;
+        }
+
+        uint64_t cycle = ms_to_cycles(ms);
+        event_t ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.cycle = cycle;
+
+        if (strcmp(action, "pir") == 0 && n == 3) {
+            add_pin_event(cycle, PIR_PORT, PIR_BIT, atoi(arg) ? 1 : 0);
+        } else if (strcmp(action, "ir") == 0 && n == 3) {
+            add_nec_frame(cycle, 0x00, (uint8_t)strtoul(arg, NULL, 0));
+        } else if (strcmp(action, "mark") == 0 && n == 3) {
+            ev.kind = EV_MARK;
+            strncpy(ev.label, arg, sizeof(ev.label) - 1);
+            add_event(&ev);
+        } else if ((strcmp(action, "expect") == 0 || strcmp(action, "forbid") == 0) && n == 3) {
+            if (len >= MAX_TEXT) {
+                fprintf(stderr, "%s:%d: text longer than %d characters\n", path, line_no, MAX_TEXT - 1);
+                exit(2);
+            }
+            add_check(cycle, action[0] == 'f', text, line_no);
+        } else if (strcmp(action, "end") == 0) {
+            ev.kind = EV_END;
+            add_event(&ev);
+        } else {
+            fprintf(stderr, "%s:%d: unknown action '%s'\n", path, line_no, action);
+            exit(2);
+        }
+    }
+    fclose(f);
+
+    // Edges of one IR frame can share a cycle, so sort stably (insertion sort)
+    for (int i = 1; i < event_count; i++) {
+        event_t key = events[i];
+        int j = i - 1;
+        while (j >= 0 && compare_events(&events[j], &key) > 0) {
+            events[j + 1] = events[j];
+            j--;
+        }
+        events[j + 1] = key;
+    }
+
+    // A forbid holds until the next mark
+    for (int i = 0; i < forbid_count; i++) {
+        for (int j = 0; j < event_count; j++) {
+            if (events[j].kind == EV_MARK && events[j].cycle > forbids[i].cycle) {
+                forbids[i].until = events[j].cycle;
+                break;
+            }
+        }
+    }
+}
+
+static void start_phase(const char* name) {
+    // A phase that hasn't recorded anything yet is just renamed
+    if (phase_count > 0) {
+        int empty = 1;
+        for (int i = 0; i < func_count; i++) {
+            if (phases[phase_count - 1].stats[i].calls) {
+                empty = 0;
+            }
+        }
+        if (empty) {
+            phase_count--;
+        }
+    }
+    if (phase_count >= MAX_PHASES) {
+        fprintf(stderr, "simavr_bench: too many phases (max %d)\n", MAX_PHASES);
+        exit(2);
+    }
+    phase_t* p = &phases[phase_count++];
+    memset(p, 0, sizeof(*p));
+    strncpy(p->name, name, sizeof(p->name) - 1);
+    for (int i = 0; i < MAX_FUNCS; i++) {
+        p->stats[i].min = UINT64_MAX;
+    }
+}
+
+static uint16_t read_sp(void) {
+    return avr->data[SPL_ADDR] | (avr->data[SPH_ADDR] << 8);
+}
+
+static void push_frame(int func) {
+    if (depth < MAX_DEPTH) {
+        frames[depth].func = func;
+        frames[depth].start = avr->cycle;
+        frames[depth].sp = read_sp();
+        frames[depth].isr = 0;
+        depth++;
+    }
+}
+
+static void record_call(int func, uint64_t cycles, uint64_t isr) {
+    func_stats_t* s = &phases[phase_count - 1].stats[func];
+    s->calls++;
+    s->total += cycles;
+    s->isr += isr;
+    if (cycles < s->min) s->min = cycles;
+    if (cycles > s->max) s->max = cycles;
+}
+
+static void fan_changed(int on) {
+    if (on && !fan_on && motion_pending) {
+        uint64_t latency = avr->cycle - motion_cycle;
+        lat_samples++;
+        lat_total += latency;
+        if (latency < lat_min) lat_min = latency;
+        if (latency > lat_max) lat_max = latency;
+        motion_pending = 0;
+    }
+    fan_on = on;
+}
+
+// analogWrite(9, 255) becomes a plain digitalWrite HIGH on PB1
+static void fan_pin_hook(struct avr_irq_t* irq, uint32_t value, void* param) {
+    (void)irq; (void)param;
+    fan_changed(value != 0);
+}
+
+// analogWrite(9, 1..254) programs OCR1A
+static void fan_pwm_hook(struct avr_irq_t* irq, uint32_t value, void* param) {
+    (void)irq; (void)param;
+    fan_changed(value != 0);
+}
+
+// Checks one complete serial line against the expected and forbidden output
+static void uart_line_done(const char* line) {
+    if (next_expect < expect_count && strstr(line, expects[next_expect].text)) {
+        next_expect++;
+    }
+    for (int i = 0; i < forbid_count; i++) {
+        const check_t* c = &forbids[i];
+        if (avr->cycle >= c->cycle && avr->cycle < c->until && strstr(line, c->text)) {
+            fprintf(stderr, "simavr_bench: scenario line %d: \"%s\" printed at %.1f ms\n",
+                    c->line_no, line, cycles_to_ms(avr->cycle));
+            check_failed = 1;
+        }
+    }
+    strncpy(last_line, line, sizeof(last_line) - 1);
+}
+
+static void uart_hook(struct avr_irq_t* irq, uint32_t value, void* param) {
+    (void)irq; (void)param;
+    char c = (char)(value & 0xFF);
+    if (uart_log) {
+        fputc(c, uart_log);
+    }
+    if (c == '\n') {
+        uart_line[uart_len] = '\0';
+        uart_line_done(uart_line);
+        uart_len = 0;
+    } else if (c != '\r' && uart_len < MAX_LINE - 1) {
+        uart_line[uart_len++] = c;
+    }
+}
+
+// Reports the first expected line that didn't appear in time
+static void expect_missed(void) {
+    const check_t* c = &expects[next_expect];
+    fprintf(stderr, "simavr_bench: scenario line %d: expected \"%s\" by %.1f ms, "
+                    "last serial line was \"%s\"\n",
+            c->line_no, c->text, cycles_to_ms(c->cycle), last_line);
+    check_failed = 1;
+}
+
+static void apply_event(const event_t* ev) {
+    switch (ev->kind) {
+        case EV_PIN:
+            if (ev->port == PIR_PORT && ev->bit == PIR_BIT) {
+                if (ev->value && !fan_on) {
+                    motion_pending = 1;
+                    motion_cycle = avr->cycle;
+                } else if (!ev->value && motion_pending) {
+                    lat_ignored++; // Motion ended without the fan starting (e.g. INACTIVE)
+                    motion_pending = 0;
+                }
+            }
+            avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(ev->port), ev->bit), ev->value);
+            break;
+        case EV_MARK:
+            start_phase(ev->label);
+            break;
+        default:
+            break;
+    }
+}
+
+static void write_stats(FILE* out, const func_stats_t* s) {
+    fprintf(out, "{\"calls\": %llu, \"total_cycles\": %llu, \"min_cycles\": %llu, "
+                 "\"mean_cycles\": %.1f, \"max_cycles\": %llu, \"max_us\": %.2f, "
+                 "\"isr_cycles\": %llu}",
+            (unsigned long long)s->calls, (unsigned long long)s->total,
+            (unsigned long long)(s->calls ? s->min : 0),
+            s->calls ? (double)s->total / s->calls : 0.0,
+            (unsigned long long)s->max, cycles_to_us(s->max),
+            (unsigned long long)s->isr);
+}
+
+static void write_json(const char* path, const char* mcu, const elf_firmware_t* fw) {
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        exit(2);
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"mcu\": \"%s\",\n", mcu);
+    fprintf(out, "  \"f_cpu\": %u,\n", freq);
+    fprintf(out, "  \"sim_cycles\": %llu,\n", (unsigned long long)avr->cycle);
+    fprintf(out, "  \"flash_bytes\": %u,\n", (unsigned)fw->flashsize);
+    fprintf(out, "  \"sram_static_bytes\": %u,\n", (unsigned)(fw->datasize + fw->bsssize));
+
+    fprintf(out, "  \"motion_to_fan\": {\"samples\": %llu, \"ignored\": %llu, ",
+            (unsigned long long)lat_samples, (unsigned long long)lat_ignored);
+    fprintf(out, "\"min_us\": %.2f, \"mean_us\": %.2f, \"max_us\": %.2f, \"max_cycles\": %llu},\n",
+            lat_samples ? cycles_to_us(lat_min) : 0.0,
+            lat_samples ? cycles_to_us(lat_total) / lat_samples : 0.0,
+            cycles_to_us(lat_max), (unsigned long long)lat_max);
+
+    fprintf(out, "  \"phases\": [\n");
+    for (int p = 0; p < phase_count; p++) {
+        fprintf(out, "    {\"name\": \"%s\", \"functions\": {", phases[p].name);
+        int first = 1;
+        for (int i = 0; i < func_count; i++) {
+            if (phases[p].stats[i].calls == 0) {
+                continue;
+            }
+            fprintf(out, "%s\n      \"%s\": ", first ? "" : ",", funcs[i].name);
+            write_stats(out, &phases[p].stats[i]);
+            first = 0;
+        }
+        fprintf(out, "%s}}%s\n", first ? "" : "\n    ", p + 1 < phase_count ? "," : "");
+    }
+    fprintf(out, "  ],\n");
+
+    // Totals across all phases
+    fprintf(out, "  \"total\": {");
+    int first = 1;
+    for (int i = 0; i < func_count; i++) {
+        func_stats_t t = {0, 0, UINT64_MAX, 0, 0};
+        for (int p = 0; p < phase_count; p++) {
+            const func_stats_t* s = &phases[p].stats[i];
+            t.calls += s->calls;
+            t.total += s->total;
+            t.isr += s->isr;
+            if (s->calls && s->min < t.min) t.min = s->min;
+            if (s->max > t.max) t.max = s->max;
+        }
+        fprintf(out, "%s\n    \"%s\": ", first ? "" : ",", funcs[i].name);
+        write_stats(out, &t);
+        first = 0;
+    }
+    fprintf(out, "%s}\n}\n", first ? "" : "\n  ");
+    fclose(out);
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: simavr_bench --firmware ELF --scenario FILE --json OUT\n"
+            "                    [--func name=0xADDR ...] [--mcu atmega328p] [--freq 16000000]\n"
+            "                    [--uart-log FILE]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    const char* firmware_path = NULL;
+    const char* scenario_path = NULL;
+    const char* json_path = NULL;
+    const char* mcu = "atmega328p";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--firmware") == 0 && i + 1 < argc) {
+            firmware_path = argv[++i];
+        } else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            scenario_path = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--mcu") == 0 && i + 1 < argc) {
+            mcu = argv[++i];
+        } else if (strcmp(argv[i], "--freq") == 0 && i + 1 < argc) {
+            freq = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--uart-log") == 0 && i + 1 < argc) {
+            uart_log = fopen(argv[++i], "w");
+            if (!uart_log) {
+                perror(argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--func") == 0 && i + 1 < argc) {
+            char* spec = argv[++i];
+            char* eq = strchr(spec, '=');
+            if (!eq || func_count >= MAX_FUNCS) {
+                usage();
+            }
+            *eq = '\0';
+            strncpy(funcs[func_count].name, spec, sizeof(funcs[func_count].name) - 1);
+            funcs[func_count].addr = (uint32_t)strtoul(eq + 1, NULL, 0);
+            func_count++;
+        } else {
+            usage();
+        }
+    }
+    if (!firmware_path || !scenario_path || !json_path) {
+        usage();
+    }
+
+    elf_firmware_t fw;
+    memset(&fw, 0, sizeof(fw));
+    if (elf_read_firmware(firmware_path, &fw) != 0) {
+        fprintf(stderr, "simavr_bench: can't load %s\n", firmware_path);
+        return 2;
+    }
+
+    avr = avr_make_mcu_by_name(mcu);
+    if (!avr) {
+        fprintf(stderr, "simavr_bench: unknown MCU %s\n", mcu);
+        return 2;
+    }
+    avr_init(avr);
+    avr->frequency = freq;
+    avr->log = LOG_ERROR;
+    avr_load_firmware(avr, &fw);
+
+#ifdef AVR_IOCTL_UART_SET_FLAGS
+    // Keep firmware serial output off simavr's stdout
+    uint32_t uart_flags = 0;
+    avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &uart_flags);
+    uart_flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &uart_flags);
+#endif
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+                            uart_hook, NULL);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(FAN_PORT), FAN_BIT),
+                            fan_pin_hook, NULL);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_TIMER_GETIRQ('1'), TIMER_IRQ_OUT_PWM0),
+                            fan_pwm_hook, NULL);
+
+    // Idle input levels: no motion, TSOP output HIGH
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(PIR_PORT), PIR_BIT), 0);
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(IR_PORT), IR_BIT), 1);
+
+    start_phase("start");
+    load_scenario(scenario_path);
+
+    uint64_t end_cycle = UINT64_MAX;
+    for (int i = 0; i < event_count; i++) {
+        if (events[i].kind == EV_END) {
+            end_cycle = events[i].cycle;
+            break;
+        }
+    }
+    if (end_cycle == UINT64_MAX) {
+        fprintf(stderr, "simavr_bench: scenario has no 'end'\n");
+        return 2;
+    }
+
+    int next_event = 0;
+    int state = cpu_Running;
+    while (avr->cycle < end_cycle && state != cpu_Done && state != cpu_Crashed && !check_failed) {
+        if (next_expect < expect_count && avr->cycle > expects[next_expect].cycle) {
+            expect_missed();
+            break;
+        }
+
+        while (next_event < event_count && events[next_event].cycle <= avr->cycle) {
+            apply_event(&events[next_event++]);
+        }
+
+        // An interrupt was just taken: its time is charged to no caller
+        if (avr->pc > 0 && avr->pc < VECTOR_TABLE_BYTES) {
+            push_frame(-1);
+        }
+
+        // Entering a profiled function (call, tail jump or ISR behind its vector)
+        for (int i = 0; i < func_count; i++) {
+            if (avr->pc == funcs[i].addr) {
+                push_frame(i);
+                break;
+            }
+        }
+
+        state = avr_run(avr); // Executes one instruction
+
+        // ret/reti pops the return address, leaving SP above the entry value.
+        // Interrupt time propagates up so every caller excludes it.
+        uint16_t sp = read_sp();
+        while (depth > 0 && sp > frames[depth - 1].sp) {
+            depth--;
+            const frame_t* f = &frames[depth];
+            uint64_t cycles = avr->cycle - f->start;
+            if (f->func >= 0) {
+                record_call(f->func, cycles - f->isr, f->isr);
+            }
+            if (depth > 0) {
+                frames[depth - 1].isr += (f->func < 0) ? cycles : f->isr;
+            }
+        }
+    }
+
+    if (state == cpu_Crashed) {
+        fprintf(stderr, "simavr_bench: firmware crashed at pc=0x%04x, cycle %llu\n",
+                (unsigned)avr->pc, (unsigned long long)avr->cycle);
+        return 1;
+    }
+    if (!check_failed && next_expect < expect_count) {
+        expect_missed(); // Deadline at or after 'end'
+    }
+    if (uart_log) {
+        fflush(uart_log);
+    }
+    if (check_failed) {
+        return 3;
+    }
+    fprintf(stderr, "simavr_bench: %d expected serial lines seen, %d forbid rules held\n",
+            expect_count, forbid_count);
+
+    write_json(json_path, mcu, &fw);
+    if (uart_log) {
+        fclose(uart_log);
+    }
+    return 0;
+}
@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+"""Cycle-accurate loop benchmark for the Nano firmware under simavr.
+
+Builds the `nano` and `nano_bench` PlatformIO environments, then runs both
+images through the simavr harness (bench/simavr_bench.c) with a scripted
+PIR/IR scenario:
+
+  - nano        flash/SRAM usage and worst-case motion-to-fan latency of the
+                firmware that actually gets flashed
+  - nano_bench  the same firmware built without LTO, so loop(), every
+                component update() and the ISRs keep their own symbols and
+                can be profiled per call
+
+The harness checks the firmware's serial output against the state
+transitions the scenario expects; a mismatch fails the run.
+
+Results are written as JSON. They are compared against --baseline (default
+bench/baseline.json when it exists): metrics that got worse by more than
+--tolerance percent are listed and the script exits with status 1.
+
+Requires PlatformIO, a C compiler and simavr (libsimavr + headers, libelf).
+
+    python3 bench/simavr_bench.py --output bench/baseline.json
+    python3 bench/simavr_bench.py --no-build
+"""
+
+import argparse
+import json
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+BENCH_DIR = os.path.join(ROOT, "bench")
+HARNESS_SRC = os.path.join(BENCH_DIR, "simavr_bench.c")
+HARNESS_BIN = os.path.join(BENCH_DIR, ".build", "simavr_bench")
+DEFAULT_BASELINE = os.path.join(BENCH_DIR, "baseline.json")
+
+# Harness exit status when the serial output doesn't match the scenario
+EXIT_UART_MISMATCH = 3
+
+MCU = "atmega328p"
+F_CPU = 16000000
+FLASH_MAX = 30720  # 32KB minus the 2KB bootloader
+SRAM_MAX = 2048
+
+# Report name -> candidate ELF symbols (first one found wins)
+PROFILE_FUNCS = [
+    ("loop", ["loop", "_Z4loopv"]),
+    ("PIRSensor::update", ["_ZN9PIRSensor6updateEv"]),
+    ("Buzzer::update", ["_ZN6Buzzer6updateEv"]),
+    ("IRRemote::update", ["_ZN8IRRemote6updateEv"]),
+    ("DeviceStateMachine::update", ["_ZN18DeviceStateMachine6updateEv"]),
+    ("EventJournal::update", ["_ZN12EventJournal6updateEv"]),
+    ("RGBLED::update", ["_ZN6RGBLED6updateEv"]),
+    ("isr:TIMER0_OVF (millis)", ["__vector_16"]),
+    ("isr:TIMER1_OVF (blue PWM)", ["__vector_13"]),
+    ("isr:TIMER1_COMPB (blue PWM)", ["__vector_12"]),
+    ("isr:TIMER2_COMPA (tone)", ["__vector_7"]),
+    ("isr:TIMER2_COMPB (IRremote)", ["__vector_8"]),
+    ("isr:USART_UDRE (Serial TX)", ["__vector_19"]),
+]
+
+# Metrics compared against a baseline (a larger value is a regression)
+BASELINE_KEYS = ("flash_bytes", "sram_static_bytes", "max_us", "mean_cycles", "max_cycles")
+
+
+def read_function_symbols(elf_path):
+    """Returns {symbol name: address} for every FUNC symbol in an ELF32 file."""
+    with open(elf_path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF" or data[4] != 1:
+        raise ValueError("%s is not an ELF32 file" % elf_path)
+
+    e_shoff, = struct.unpack_from("<I", data, 0x20)
+    e_shentsize, e_shnum = struct.unpack_from("<HH", data, 0x2E)
+    sections = [struct.unpack_from("<IIIIIIIIII", data, e_shoff + i * e_shentsize)
+                for i in range(e_shnum)]
+
+    symbols = {}
+    for sh_name, sh_type, _, _, sh_offset, sh_size, sh_link, _, _, sh_entsize in sections:
+        if sh_type != 2:  # SHT_SYMTAB
+            continue
+        strtab_offset = sections[sh_link][4]
+        for off in range(sh_offset, sh_offset + sh_size, sh_entsize or 16):
+            st_name, st_value, _, st_info, _, _ = struct.unpack_from("<IIIBBH", data, off)
+            if st_info & 0xF != 2:  # STT_FUNC
+                continue
+            end = data.index(b"\0", strtab_offset + st_name)
+            symbols[data[strtab_offset + st_name:end].decode()] = st_value
+    return symbols
+
+
+def simavr_flags():
+    """Compiler and linker flags for simavr, from pkg-config when available."""
+    if shutil.which("pkg-config"):
+        result = subprocess.run(["pkg-config", "--cflags", "--libs", "simavr"],
+                                capture_output=True, text=True)
+        if result.returncode == 0:
+            return result.stdout.split() + ["-lelf"]
+    return ["-I/usr/include/simavr", "-I/usr/local/include/simavr",
+            "-L/usr/local/lib", "-lsimavr", "-lelf"]
+
+
+def build_harness():
+    if (os.path.exists(HARNESS_BIN)
+            and os.path.getmtime(HARNESS_BIN) >= os.path.getmtime(HARNESS_SRC)):
+        return
+    os.makedirs(os.path.dirname(HARNESS_BIN), exist_ok=True)
+    cc = os.environ.get("CC", "cc")
+    cmd = [cc, "-O2", "-std=gnu99", "-o", HARNESS_BIN, HARNESS_SRC] + simavr_flags()
+    print("Building harness: " + " ".join(cmd), file=sys.stderr)
+    subprocess.run(cmd, check=True)
+
+
+def build_firmware(pio):
+    cmd = [pio, "run", "-e", "nano", "-e", "nano_bench"]
+    print("Building firmware: " + " ".join(cmd), file=sys.stderr)
+    subprocess.run(cmd, cwd=ROOT, check=True)
+
+
+def start_harness(elf, scenario, json_path, funcs=(), uart_log=None):
+    cmd = [HARNESS_BIN, "--firmware", elf, "--scenario", scenario, "--json", json_path,
+           "--mcu", MCU, "--freq", str(F_CPU)]
+    for name, addr in funcs:
+        cmd += ["--func", "%s=0x%x" % (name, addr)]
+    if uart_log:
+        cmd += ["--uart-log", uart_log]
+    return subprocess.Popen(cmd)
+
+
+def memory_usage(run):
+    return {
+        "flash_bytes": run["flash_bytes"],
+        "flash_max": FLASH_MAX,
+        "flash_pct": round(100.0 * run["flash_bytes"] / FLASH_MAX, 1),
+        "sram_static_bytes": run["sram_static_bytes"],
+        "sram_max": SRAM_MAX,
+        "sram_pct": round(100.0 * run["sram_static_bytes"] / SRAM_MAX, 1),
+    }
+
+
+def flatten(node, prefix=""):
+    """Yields (path, value) for every number in the result, naming phases by their name."""
+    if isinstance(node, dict):
+        for key, value in node.items():
+            yield from flatten(value, prefix + "/" + key if prefix else key)
+    elif isinstance(node, list):
+        for item in node:
+            label = item.get("name", "?") if isinstance(item, dict) else "?"
+            yield from flatten(item, prefix + "/" + label)
+    elif isinstance(node, (int, float)) and not isinstance(node, bool):
+        yield prefix, node
+
+
+def compare_to_baseline(result, baseline, tolerance_pct):
+    old = dict(flatten(baseline))
+    regressions = []
+    for path, new_value in flatten(result):
+        if not path.endswith(BASELINE_KEYS) or path not in old:
+            continue
+        old_value = old[path]
+        if new_value > old_value * (1 + tolerance_pct / 100.0):
+            regressions.append((path, old_value, new_value))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--scenario", default=os.path.join(BENCH_DIR, "scenarios", "activation.txt"))
+    parser.add_argument("--output", help="write the JSON result here (default: stdout)")
+    parser.add_argument("--baseline", help="previous JSON result to compare against "
+                                           "(default: bench/baseline.json if present)")
+    parser.add_argument("--tolerance", type=float, default=5.0,
+                        help="allowed increase in percent before a metric counts as a regression")
+    parser.add_argument("--no-build", action="store_true", help="use the existing firmware.elf files")
+    parser.add_argument("--pio", default="pio", help="PlatformIO command")
+    parser.add_argument("--uart-log", help="save the nano firmware's serial output here")
+    args = parser.parse_args()
+
+    if not args.no_build:
+        build_firmware(args.pio)
+    build_harness()
+
+    nano_elf = os.path.join(ROOT, ".pio", "build", "nano", "firmware.elf")
+    bench_elf = os.path.join(ROOT, ".pio", "build", "nano_bench", "firmware.elf")
+
+    symbols = read_function_symbols(bench_elf)
+    funcs, unresolved = [], []
+    for name, candidates in PROFILE_FUNCS:
+        found = [symbols[c] for c in candidates if c in symbols]
+        if found:
+            funcs.append((name, found[0]))
+        else:
+            unresolved.append(name)
+
+    # Both images run in parallel; each simulation is single threaded
+    with tempfile.TemporaryDirectory() as tmp:
+        nano_json = os.path.join(tmp, "nano.json")
+        bench_json = os.path.join(tmp, "nano_bench.json")
+        procs = [
+            start_harness(nano_elf, args.scenario, nano_json, uart_log=args.uart_log),
+            start_harness(bench_elf, args.scenario, bench_json, funcs=funcs),
+        ]
+        codes = [p.wait() for p in procs]
+        if EXIT_UART_MISMATCH in codes:
+            sys.exit("simavr_bench: serial output did not match the scenario (see above)")
+        if any(codes):
+            sys.exit("simavr_bench: simulation failed")
+        with open(nano_json) as f:
+            nano_run = json.load(f)
+        with open(bench_json) as f:
+            bench_run = json.load(f)
+
+    result = {
+        "schema_version": 1,
+        "scenario": os.path.splitext(os.path.basename(args.scenario))[0],
+        "mcu": MCU,
+        "f_cpu": F_CPU,
+        "sim_cycles": nano_run["sim_cycles"],
+        "memory": {
+            "nano": memory_usage(nano_run),
+            "nano_bench": memory_usage(bench_run),
+        },
+        "motion_to_fan": nano_run["motion_to_fan"],
+        "profile": {
+            "env": "nano_bench",
+            "unresolved": unresolved,
+            "phases": bench_run["phases"],
+            "total": bench_run["total"],
+        },
+    }
+
+    text = json.dumps(result, indent=2)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+    else:
+        print(text)
+
+    baseline_path = args.baseline
+    if baseline_path is None and os.path.exists(DEFAULT_BASELINE) \
+            and os.path.abspath(args.output or "") != DEFAULT_BASELINE:
+        baseline_path = DEFAULT_BASELINE
+    if baseline_path:
+        with open(baseline_path) as f:
+            baseline = json.load(f)
+        regressions = compare_to_baseline(result, baseline, args.tolerance)
+        for path, old_value, new_value in regressions:
+            print("REGRESSION %s: %s -> %s" % (path, old_value, new_value), file=sys.stderr)
+        if regressions:
+            sys.exit(1)
+        print("No regressions beyond %.1f%%" % args.tolerance, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
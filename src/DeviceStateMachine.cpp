@@ -2,19 +2,17 @@
 
 // Constructor implementation
 DeviceStateMachine::DeviceStateMachine(PIRSensor& pirSensor, PWMFan& pwmFan, Buzzer& buzzerObj, 
-                                       RGBLED& rgbLed, IRRemote& irRemote, 
+                                       RGBLED& rgbLed, IRRemote& irRemote, EventJournal& eventJournal,
                                        unsigned long durationMs, int fanSpeed)
-    : pir(pirSensor), fan(pwmFan), buzzer(buzzerObj), led(rgbLed), ir(irRemote),
-      currentState(WARMUP), activationStartTime(0), lastFlicker(0), ledState(false),
+    : pir(pirSensor), fan(pwmFan), buzzer(buzzerObj), led(rgbLed), ir(irRemote), journal(eventJournal),
+      currentState(WARMUP), activationStartTime(0), activeEnteredTime(0),
       activationDurationMs(durationMs), fanSpeedActivated(fanSpeed) {
 }
 
 // begin() method implementation
 void DeviceStateMachine::begin() {
-    currentState = WARMUP;
     activationStartTime = 0;
-    lastFlicker = 0;
-    ledState = false;
+    changeState(WARMUP);
     Serial.println("Device State Machine initialized.");
 }
 
@@ -40,25 +38,49 @@ void DeviceStateMachine::update() {
     }
 }
 
+// changeState() method implementation
+void DeviceStateMachine::changeState(DeviceState newState) {
+    DeviceState oldState = currentState;
+    currentState = newState;
+    
+    // Journal ACTIVE periods and IR toggles
+    if (newState != oldState) {
+        if (oldState == ACTIVE) {
+            unsigned long activeSec = (millis() - activeEnteredTime) / 1000;
+            journal.logEvent(JOURNAL_ACTIVATION, activeSec > 0xFFFF ? 0xFFFF : activeSec);
+        }
+        if (oldState == INACTIVE) {
+            journal.logEvent(JOURNAL_IR_ENABLE);
+        }
+        if (newState == ACTIVE) {
+            activeEnteredTime = millis();
+        }
+        if (newState == INACTIVE) {
+            journal.logEvent(JOURNAL_IR_DISABLE);
+        }
+    }
+    
+    // Each state owns an LED animation; RGBLED::update() plays it from the main loop
+    switch (newState) {
+        case WARMUP:   led.playAnimation(&ANIM_WARMUP);   break; // Blue blink
+        case STANDBY:  led.playAnimation(&ANIM_STANDBY);  break; // Green = ready
+        case ACTIVE:   led.playAnimation(&ANIM_ACTIVE);   break; // Red
+        case INACTIVE: led.playAnimation(&ANIM_INACTIVE); break; // Yellow = inactive
+    }
+}
+
 // handleWarmupState() method implementation
 void DeviceStateMachine::handleWarmupState() {
     // Check for IR power toggle (can interrupt warm-up)
     if (ir.checkPowerToggle()) {
-        currentState = INACTIVE;
+        changeState(INACTIVE);
         Serial.println("IR Power toggle: Entering inactive mode.");
         return;
     }
     
-    // Flicker blue LED during warm-up
-    if (millis() - lastFlicker >= 500) { // Flicker every 500ms
-        ledState = !ledState;
-        led.setColor(0, 0, ledState ? 255 : 0); // Blue on/off
-        lastFlicker = millis();
-    }
-    
     // Check if warm-up is complete
     if (!pir.isInitializing()) {
-        currentState = STANDBY;
+        changeState(STANDBY);
         Serial.println("Warm-up complete. Entering standby mode.");
     }
 }
@@ -67,23 +89,19 @@ void DeviceStateMachine::handleWarmupState() {
 void DeviceStateMachine::handleStandbyState() {
     // Check for IR power toggle
     if (ir.checkPowerToggle()) {
-        currentState = INACTIVE;
+        changeState(INACTIVE);
         Serial.println("IR Power toggle: Entering inactive mode.");
         return;
     }
     
-    // Show green LED to indicate ready state
-    led.setColor(0, 255, 0); // Green = ready
-    
     // Check for motion detection
     if (pir.isMotionDetected()) {
         // Transition to active state
-        currentState = ACTIVE;
+        changeState(ACTIVE);
         activationStartTime = millis();
         
         Serial.println("Motion detected! Activating deterrent...");
         Serial.println("Setting LED to RED (255,0,0)");
-        led.setColor(255, 0, 0); // Red
         fan.turnOn(fanSpeedActivated);
         buzzer.startSiren();
     }
@@ -93,11 +111,12 @@ void DeviceStateMachine::handleStandbyState() {
 void DeviceStateMachine::handleActiveState() {
     // Check for IR power toggle (can interrupt active state)
     if (ir.checkPowerToggle()) {
-        currentState = INACTIVE;
+        changeState(INACTIVE);
         Serial.println("IR Power toggle: Entering inactive mode.");
         // Stop deterrent immediately
         fan.turnOff();
         buzzer.stopSiren();
+        ir.restartReceiver(); // The siren's tone() took over the IR sample timer
         return;
     }
     
@@ -109,13 +128,13 @@ void DeviceStateMachine::handleActiveState() {
     // Check if activation duration has expired
     if (millis() - activationStartTime >= activationDurationMs) {
         // Transition back to standby
-        currentState = STANDBY;
+        changeState(STANDBY);
         
         Serial.println("Deactivating deterrent...");
         Serial.println("Setting LED to GREEN (0,255,0)");
-        led.setColor(0, 255, 0); // Green
         fan.turnOff();
         buzzer.stopSiren();
+        ir.restartReceiver(); // The siren's tone() took over the IR sample timer
     }
 }
 
@@ -123,14 +142,11 @@ void DeviceStateMachine::handleActiveState() {
 void DeviceStateMachine::handleInactiveState() {
     // Check for IR power toggle to exit inactive state
     if (ir.checkPowerToggle()) {
-        currentState = STANDBY;
+        changeState(STANDBY);
         Serial.println("IR Power toggle: Exiting inactive mode, entering standby.");
         return;
     }
     
-    // Show yellow LED to indicate inactive state (red + green)
-    led.setColor(255, 255, 0); // Yellow = inactive
-    
     // In inactive state, ignore all PIR motion detection
     // No deterrent activation occurs
 }
@@ -142,7 +158,7 @@ DeviceState DeviceStateMachine::getCurrentState() const {
 
 // setState() method implementation
 void DeviceStateMachine::setState(DeviceState newState) {
-    currentState = newState;
+    changeState(newState);
     Serial.print("State changed to: ");
     Serial.println(getStateName());
 }
@@ -7,6 +7,7 @@
 #include "Buzzer.h"
 #include "RGBLED.h"
 #include "IRRemote.h"
+#include "EventJournal.h"
 
 // Device states
 enum DeviceState {
@@ -24,17 +25,20 @@ private:
     Buzzer& buzzer;
     RGBLED& led;
     IRRemote& ir;
+    EventJournal& journal;
     
     // State variables
     DeviceState currentState;
     unsigned long activationStartTime;
-    unsigned long lastFlicker;
-    bool ledState;
+    unsigned long activeEnteredTime;  // When ACTIVE was entered (activationStartTime refreshes)
     
     // Configuration
     unsigned long activationDurationMs;
     int fanSpeedActivated;
     
+    // Switches state, starts the matching LED animation and journals the transition
+    void changeState(DeviceState newState);
+    
     // State handling methods
     void handleWarmupState();
     void handleStandbyState();
@@ -44,7 +48,7 @@ private:
 public:
     // Constructor
     DeviceStateMachine(PIRSensor& pirSensor, PWMFan& pwmFan, Buzzer& buzzerObj, 
-                      RGBLED& rgbLed, IRRemote& irRemote, 
+                      RGBLED& rgbLed, IRRemote& irRemote, EventJournal& eventJournal,
                       unsigned long durationMs = 5000, int fanSpeed = 255);
     
     // Initialize the state machine
@@ -0,0 +1,284 @@
+#include "EventJournal.h"
+#include <EEPROM.h>
+
+// Constructor implementation
+EventJournal::EventJournal(int startAddress, int sizeBytes)
+    : _startAddress(startAddress), _slotCount(sizeBytes / sizeof(JournalRecord)),
+      _head(0), _full(false), _nextSeq(0), _lastEventMs(0),
+      _pendingCount(0), _oldestPendingMs(0), _flushByte(0),
+      _dumpOut(0), _dumpStage(DUMP_IDLE), _dumpSeq(0), _dumpEnd(0) {
+    // Initialize member variables
+}
+
+// begin() method implementation
+void EventJournal::begin() {
+#if defined(ESP32) || defined(ESP8266)
+    // EEPROM emulation on ESP needs to know the region size up front
+    EEPROM.begin(_startAddress + _slotCount * sizeof(JournalRecord));
+#endif
+
+    // Slots [0, head) hold consecutive sequence numbers starting at slot 0's.
+    // Everything from head on is blank, torn, or an older lap, so the first
+    // slot that breaks the run can be found by binary search.
+    JournalRecord first;
+    uint16_t lo = 0;
+    if (readSlot(0, first)) {
+        lo = 1;
+        uint16_t hi = _slotCount;
+        while (lo < hi) {
+            uint16_t mid = lo + (hi - lo) / 2;
+            if (slotHasSeq(mid, (uint16_t)(first.seq + mid))) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+    }
+
+    JournalRecord rec;
+    if (lo == _slotCount) {
+        // Every slot is in the run: the last write filled the final slot
+        _head = 0;
+        _full = true;
+    } else {
+        _head = lo;
+        // An older lap behind head (possibly past one torn slot) means the log has wrapped
+        _full = readSlot(_head, rec) ||
+                (_head + 1 < _slotCount && readSlot(_head + 1, rec));
+    }
+
+    // Continue numbering from the newest record
+    uint16_t newest = (_head == 0) ? _slotCount - 1 : _head - 1;
+    _nextSeq = readSlot(newest, rec) ? rec.seq + 1 : 0;
+
+    Serial.print("Event journal: ");
+    Serial.print(getRecordCount());
+    Serial.print(" records, next slot ");
+    Serial.println(_head);
+    Serial.println("Send 'J' via serial to dump the event journal");
+
+    // Time spent powered off is unknown, so the BOOT record has no delta
+    _lastEventMs = millis();
+    logEvent(JOURNAL_BOOT);
+}
+
+// update() method implementation - call this in main loop
+void EventJournal::update() {
+#if defined(__AVR__)
+    // Trickle records out one byte at a time so loop() never waits on the EEPROM
+    if (_pendingCount > 0 && eeprom_is_ready()) {
+        writeNextByte();
+    }
+#else
+    bool due = _pendingCount >= JOURNAL_BATCH_SIZE ||
+               (_pendingCount > 0 && millis() - _oldestPendingMs >= JOURNAL_FLUSH_INTERVAL_MS);
+    if (due) {
+        flush();
+    }
+#endif
+
+    // Stream the dump only as fast as the output buffer drains
+    if (_dumpStage != DUMP_IDLE && _dumpOut->availableForWrite() >= JOURNAL_DUMP_LINE_BYTES) {
+        dumpNextLine();
+    }
+}
+
+// logEvent() method implementation
+void EventJournal::logEvent(JournalEvent type, uint16_t durationSec) {
+    if (_pendingCount >= JOURNAL_BATCH_SIZE) {
+        flush(); // Queue is full, make room
+    }
+
+    // Advance by whole seconds so rounding doesn't drift over many records
+    unsigned long now = millis();
+    unsigned long deltaSec = (now - _lastEventMs) / 1000;
+    _lastEventMs += deltaSec * 1000;
+
+    JournalRecord& rec = _pending[_pendingCount];
+    rec.seq = _nextSeq++;
+    rec.type = type;
+    rec.deltaSec = deltaSec > 0xFFFF ? 0xFFFF : deltaSec;
+    rec.durationSec = durationSec;
+    rec.crc = computeCrc(rec);
+
+    if (_pendingCount == 0) {
+        _oldestPendingMs = now;
+    }
+    _pendingCount++;
+}
+
+// flush() method implementation
+void EventJournal::flush() {
+#if defined(__AVR__)
+    // EEPROM.update() waits for the previous byte to finish
+    while (_pendingCount > 0) {
+        writeNextByte();
+    }
+#else
+    if (_pendingCount == 0) {
+        return;
+    }
+    while (_pendingCount > 0) {
+        EEPROM.put(_startAddress + _head * sizeof(JournalRecord), _pending[0]);
+        recordWritten();
+    }
+    EEPROM.commit(); // One flash commit for the whole batch
+#endif
+}
+
+// dump() method implementation
+void EventJournal::dump(Print& out) {
+    if (_dumpStage != DUMP_IDLE) {
+        return;
+    }
+    _dumpOut = &out;
+    _dumpEnd = _nextSeq;
+    _dumpSeq = _nextSeq - getRecordCount();
+    _dumpStage = DUMP_HEADER;
+}
+
+// isDumping() method implementation
+bool EventJournal::isDumping() const {
+    return _dumpStage != DUMP_IDLE;
+}
+
+// getRecordCount() method implementation
+uint16_t EventJournal::getRecordCount() const {
+    return (_full ? _slotCount : _head) + _pendingCount;
+}
+
+// getEventName() method implementation
+const char* EventJournal::getEventName(uint8_t type) {
+    switch (type) {
+        case JOURNAL_BOOT: return "BOOT";
+        case JOURNAL_ACTIVATION: return "ACTIVATION";
+        case JOURNAL_IR_DISABLE: return "IR_DISABLE";
+        case JOURNAL_IR_ENABLE: return "IR_ENABLE";
+        default: return "UNKNOWN";
+    }
+}
+
+// readSlot() method implementation - returns false for blank or torn slots
+bool EventJournal::readSlot(uint16_t slot, JournalRecord& rec) {
+    EEPROM.get(_startAddress + slot * sizeof(JournalRecord), rec);
+    return rec.type >= JOURNAL_BOOT && rec.type <= JOURNAL_IR_ENABLE &&
+           rec.crc == computeCrc(rec);
+}
+
+// slotHasSeq() method implementation
+bool EventJournal::slotHasSeq(uint16_t slot, uint16_t seq) {
+    JournalRecord rec;
+    return readSlot(slot, rec) && rec.seq == seq;
+}
+
+// findRecord() method implementation - looks up a record by sequence number,
+// in RAM if it is still pending, otherwise in its EEPROM slot
+bool EventJournal::findRecord(uint16_t seq, JournalRecord& rec) {
+    uint16_t back = _nextSeq - seq; // 1 = newest record
+    if (back <= _pendingCount) {
+        rec = _pending[_pendingCount - back];
+        return true;
+    }
+
+    back -= _pendingCount;
+    uint16_t stored = _full ? _slotCount : _head;
+    if (back > stored) {
+        return false;
+    }
+    uint16_t slot = (_head >= back) ? _head - back : _head + _slotCount - back;
+    return readSlot(slot, rec) && rec.seq == seq;
+}
+
+// dumpNextLine() method implementation - prints one line of the running dump
+void EventJournal::dumpNextLine() {
+    switch (_dumpStage) {
+        case DUMP_HEADER:
+            _dumpOut->print("JOURNAL BEGIN ");
+            _dumpOut->println((uint16_t)(_dumpEnd - _dumpSeq));
+            _dumpStage = DUMP_COLUMNS;
+            break;
+
+        case DUMP_COLUMNS:
+            _dumpOut->println("seq,event,delta_s,duration_s");
+            _dumpStage = DUMP_RECORDS;
+            break;
+
+        case DUMP_RECORDS: {
+            // Blank or torn slots are skipped without printing anything
+            JournalRecord rec;
+            while (_dumpSeq != _dumpEnd) {
+                if (findRecord(_dumpSeq++, rec)) {
+                    printRecord(*_dumpOut, rec);
+                    return;
+                }
+            }
+            _dumpStage = DUMP_FOOTER;
+            break;
+        }
+
+        case DUMP_FOOTER:
+            _dumpOut->println("JOURNAL END");
+            _dumpStage = DUMP_IDLE;
+            break;
+
+        default:
+            break;
+    }
+}
+
+// writeNextByte() method implementation - writes one byte of the oldest pending record
+void EventJournal::writeNextByte() {
+    const uint8_t* bytes = (const uint8_t*)&_pending[0];
+    int address = _startAddress + _head * sizeof(JournalRecord) + _flushByte;
+#if defined(__AVR__)
+    EEPROM.update(address, bytes[_flushByte]); // Skips bytes that are already correct
+#else
+    EEPROM.write(address, bytes[_flushByte]);
+#endif
+    _flushByte++;
+    if (_flushByte == sizeof(JournalRecord)) {
+        _flushByte = 0;
+        recordWritten();
+    }
+}
+
+// recordWritten() method implementation - advances past the record in _pending[0]
+void EventJournal::recordWritten() {
+    _head++;
+    if (_head == _slotCount) {
+        _head = 0;
+        _full = true;
+    }
+
+    _pendingCount--;
+    for (uint8_t i = 0; i < _pendingCount; i++) {
+        _pending[i] = _pending[i + 1];
+    }
+}
+
+// computeCrc() method implementation - CRC-8 (poly 0x07) over every byte except crc
+uint8_t EventJournal::computeCrc(const JournalRecord& rec) {
+    const uint8_t* bytes = (const uint8_t*)&rec;
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < sizeof(JournalRecord); i++) {
+        if (bytes + i == &rec.crc) {
+            continue;
+        }
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// printRecord() method implementation
+void EventJournal::printRecord(Print& out, const JournalRecord& rec) {
+    out.print(rec.seq);
+    out.print(',');
+    out.print(getEventName(rec.type));
+    out.print(',');
+    out.print(rec.deltaSec);
+    out.print(',');
+    out.println(rec.durationSec);
+}
@@ -0,0 +1,137 @@
+#ifndef EVENT_JOURNAL_H
+#define EVENT_JOURNAL_H
+
+#include <Arduino.h>
+
+// Persistent activation journal.
+//
+// Events are packed into fixed-size 8-byte records and written round-robin
+// into a circular log in EEPROM (AVR) or the flash-backed EEPROM emulation
+// (ESP32: NVS, ESP8266: flash sector). Writing every slot in turn spreads
+// wear evenly across the whole region. Each record carries a 16-bit
+// sequence number, so at boot the write position is found by binary search
+// over the slots (about log2(slots) + 4 record reads) instead of a full scan.
+//
+// On ESP, records are buffered in RAM and committed in batches (see
+// JOURNAL_BATCH_SIZE and JOURNAL_FLUSH_INTERVAL_MS) to limit flash erases.
+// AVR EEPROM is byte-erasable and unchanged bytes are skipped, so batching
+// would buy no endurance there and only lose events on power loss: each
+// record starts writing as soon as it is queued, one byte per update() so
+// loop() never stalls on the ~3.4ms EEPROM byte write.
+//
+// Endurance for 200 activations/day (~210 records/day incl. IR toggles and boots):
+//   AVR, 1KB EEPROM = 128 slots, 100k cycles/cell, write amplification 1.0
+//     (only the record's own bytes are written, unchanged bytes are skipped)
+//     -> each slot rewritten ~1.6x/day -> ~60,000 days.
+//     The log holds the last ~14 hours of events at that rate.
+//   ESP32, EEPROM emulation stores the whole 1KB region as one NVS blob per commit
+//     -> amplification 1KB / (16 x 8B) = 8x with batching (128x without)
+//     -> worst case ~110 commits/day (96 timed flushes + 14 full batches) x ~1.1KB,
+//        spread by NVS over 4 usable 4KB pages -> ~7.5 erases/page/day -> ~36 years.
+//   ESP8266, every commit erases and rewrites the same 4KB sector
+//     -> amplification 4KB / 128B = 32x with batching (512x without)
+//     -> worst case ~110 erases/day -> ~2.5 years; without batching
+//        (~210 commits/day) the sector would wear out in ~1.3 years.
+
+// Event types stored in the journal
+enum JournalEvent {
+    JOURNAL_BOOT = 1,          // Device powered up or reset
+    JOURNAL_ACTIVATION = 2,    // Deterrent ran; logged on exit, entry was durationSec earlier
+    JOURNAL_IR_DISABLE = 3,    // IR power toggle: entered INACTIVE
+    JOURNAL_IR_ENABLE = 4      // IR power toggle: left INACTIVE
+};
+
+// One fixed-size journal record (8 bytes)
+struct JournalRecord {
+    uint16_t seq;          // Increments by one per record, wraps at 65535
+    uint8_t type;          // JournalEvent
+    uint8_t crc;           // CRC-8 of the other 7 bytes, detects blank or torn slots
+    uint16_t deltaSec;     // Seconds since the previous record (65535 = at least that long; 0 for BOOT)
+    uint16_t durationSec;  // Event duration in seconds (ACTIVATION only)
+};
+
+#if defined(__AVR__)
+static const uint8_t JOURNAL_BATCH_SIZE = 4;                        // Records queued while the EEPROM is busy (~27ms each)
+#else
+static const uint8_t JOURNAL_BATCH_SIZE = 16;                       // Records per flash commit
+static const unsigned long JOURNAL_FLUSH_INTERVAL_MS = 900000UL;    // Max time a record waits in RAM (15 minutes)
+#endif
+
+// Free space in the output buffer needed before update() prints the next dump line
+// (longest line: "65535,IR_DISABLE,65535,65535\r\n")
+static const int JOURNAL_DUMP_LINE_BYTES = 32;
+
+class EventJournal {
+public:
+    // Constructor: Uses sizeBytes of EEPROM starting at startAddress for the log.
+    EventJournal(int startAddress, int sizeBytes);
+
+    // Finds the write position by binary search and records a BOOT event.
+    void begin();
+
+    // Writes pending records (AVR: right away, ESP: when a batch is full or has
+    // waited long enough) and prints the next line of a running dump.
+    // Call this in main loop for non-blocking operation.
+    void update();
+
+    // Queues an event for the journal.
+    void logEvent(JournalEvent type, uint16_t durationSec = 0);
+
+    // Writes all pending records now (blocking).
+    void flush();
+
+    // Starts streaming every record, oldest first, as CSV lines framed by
+    // JOURNAL BEGIN/END. update() prints one line per call once out reports room
+    // for it via availableForWrite() (as Serial does), so loop() never waits on
+    // the serial port. Records logged after this call are left out. Ignored
+    // while a dump is already running.
+    void dump(Print& out);
+
+    // Returns true while a dump is being streamed.
+    bool isDumping() const;
+
+    // Number of records held (stored + pending).
+    uint16_t getRecordCount() const;
+
+    // Returns the name of an event type.
+    static const char* getEventName(uint8_t type);
+
+private:
+    enum DumpStage {
+        DUMP_IDLE,
+        DUMP_HEADER,
+        DUMP_COLUMNS,
+        DUMP_RECORDS,
+        DUMP_FOOTER
+    };
+
+    int _startAddress;
+    uint16_t _slotCount;      // Number of record slots in the log
+    uint16_t _head;           // Next slot to write
+    bool _full;               // Log has wrapped, oldest record is at _head
+    uint16_t _nextSeq;
+    unsigned long _lastEventMs;
+
+    // Records waiting to be written, oldest first
+    JournalRecord _pending[JOURNAL_BATCH_SIZE];
+    uint8_t _pendingCount;
+    unsigned long _oldestPendingMs;
+    uint8_t _flushByte;       // AVR: next byte of _pending[0] to write
+
+    // Dump streaming state
+    Print* _dumpOut;
+    DumpStage _dumpStage;
+    uint16_t _dumpSeq;        // Sequence number of the next record to print
+    uint16_t _dumpEnd;        // First sequence number not included in the dump
+
+    bool readSlot(uint16_t slot, JournalRecord& rec);
+    bool slotHasSeq(uint16_t slot, uint16_t seq);
+    bool findRecord(uint16_t seq, JournalRecord& rec);
+    void dumpNextLine();
+    void writeNextByte();
+    void recordWritten();
+    static uint8_t computeCrc(const JournalRecord& rec);
+    static void printRecord(Print& out, const JournalRecord& rec);
+};
+
+#endif // EVENT_JOURNAL_H
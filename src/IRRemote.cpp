@@ -35,9 +35,11 @@ void IRRemote::update() {
     }
     
     // Check for serial command to simulate power toggle (for testing)
+    // Other commands are left in the buffer for the main loop
     if (Serial.available()) {
-        char command = Serial.read();
+        char command = Serial.peek();
         if (command == 'P' || command == 'p') {
+            Serial.read();
             simulatePowerToggle();
         }
     }
@@ -59,6 +61,11 @@ void IRRemote::simulatePowerToggle() {
     Serial.println("Power toggle simulated!");
 }
 
+// restartReceiver() method implementation
+void IRRemote::restartReceiver() {
+    IrReceiver.start(); // Reconfigures the 50us sample timer and resets the decoder
+}
+
 // checkPowerToggle() method implementation
 bool IRRemote::checkPowerToggle() {
     if (isPowerTogglePressed()) {
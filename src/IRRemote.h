@@ -34,6 +34,10 @@ public:
     
     // For testing - simulate power toggle via serial command
     void simulatePowerToggle();
+    
+    // Restarts IR reception. On AVR, tone()/noTone() reprogram the timer the
+    // IR receiver samples with (Timer2 on the Nano), so call this after the buzzer stops.
+    void restartReceiver();
 };
 
 #endif // IRREMOTE_H 
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "LEDAnimation.h"
+
+// --- Device state indicators ---
+
+// WARMUP: blue on for 500ms, off for 500ms
+static const LEDKeyframe WARMUP_FRAMES[] PROGMEM = {
+    {0, 0, 255, 0},   {0, 0, 255, 500},
+    {0, 0, 0, 0},     {0, 0, 0, 500},
+};
+const LEDAnimation ANIM_WARMUP PROGMEM = {WARMUP_FRAMES, 4, true};
+
+// STANDBY: solid green
+static const LEDKeyframe STANDBY_FRAMES[] PROGMEM = {
+    {0, 255, 0, 0},
+};
+const LEDAnimation ANIM_STANDBY PROGMEM = {STANDBY_FRAMES, 1, false};
+
+// ACTIVE: solid red
+static const LEDKeyframe ACTIVE_FRAMES[] PROGMEM = {
+    {255, 0, 0, 0},
+};
+const LEDAnimation ANIM_ACTIVE PROGMEM = {ACTIVE_FRAMES, 1, false};
+
+// INACTIVE: solid yellow (red + green)
+static const LEDKeyframe INACTIVE_FRAMES[] PROGMEM = {
+    {255, 255, 0, 0},
+};
+const LEDAnimation ANIM_INACTIVE PROGMEM = {INACTIVE_FRAMES, 1, false};
+
+// --- General purpose effects ---
+
+// Breathe white in and out over 4 seconds
+static const LEDKeyframe BREATHE_WHITE_FRAMES[] PROGMEM = {
+    {0, 0, 0, 0},
+    {255, 255, 255, 2000},
+    {0, 0, 0, 2000},
+};
+const LEDAnimation ANIM_BREATHE_WHITE PROGMEM = {BREATHE_WHITE_FRAMES, 3, true};
+
+// Fade around the color wheel, one second per step
+static const LEDKeyframe COLOR_CYCLE_FRAMES[] PROGMEM = {
+    {255, 0, 0, 0},
+    {255, 0, 255, 1000}, // Purple
+    {0, 0, 255, 1000},   // Blue
+    {0, 255, 255, 1000}, // Cyan
+    {0, 255, 0, 1000},   // Green
+    {255, 255, 0, 1000}, // Yellow
+    {255, 0, 0, 1000},   // Back to red
+};
+const LEDAnimation ANIM_COLOR_CYCLE PROGMEM = {COLOR_CYCLE_FRAMES, 7, true};
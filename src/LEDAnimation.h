@@ -0,0 +1,36 @@
+#ifndef LED_ANIMATION_H
+#define LED_ANIMATION_H
+
+#include <Arduino.h>
+
+// A single step of an LED animation.
+// The LED fades linearly from the previous keyframe's color to this color
+// over durationMs. A duration of 0 jumps straight to the color, so a "hold"
+// is written as a jump followed by a keyframe with the same color.
+// Colors are in perceptual (pre-gamma) space, 0-255 per channel.
+struct LEDKeyframe {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint16_t durationMs;
+};
+
+// A keyframe sequence. Both the descriptor and its keyframes live in flash
+// (PROGMEM) so animations cost no SRAM on the Nano.
+struct LEDAnimation {
+    const LEDKeyframe* frames; // PROGMEM array of keyframes
+    uint8_t frameCount;        // Number of keyframes in the array
+    bool loop;                 // Restart from the first keyframe when done
+};
+
+// Built-in animations (defined in LEDAnimation.cpp, stored in PROGMEM).
+// Device state indicators:
+extern const LEDAnimation ANIM_WARMUP PROGMEM;    // Blue blink, 500ms on/off
+extern const LEDAnimation ANIM_STANDBY PROGMEM;   // Solid green
+extern const LEDAnimation ANIM_ACTIVE PROGMEM;    // Solid red
+extern const LEDAnimation ANIM_INACTIVE PROGMEM;  // Solid yellow
+// General purpose effects:
+extern const LEDAnimation ANIM_BREATHE_WHITE PROGMEM;  // Slow white breathing
+extern const LEDAnimation ANIM_COLOR_CYCLE PROGMEM;    // Red -> purple -> blue -> cyan -> green -> yellow -> red fade loop
+
+#endif // LED_ANIMATION_H
@@ -1,9 +1,115 @@
 #include "RGBLED.h"
 
+// Software PWM for a blue pin without hardware PWM (D8 on the Nano).
+// The Arduino core runs Timer1 in 8-bit phase-correct mode (~490Hz) for
+// analogWrite() on D9/D10. Compare channel B is free because D10 is unused,
+// so OCR1B holds the blue duty cycle and its interrupts toggle the pin:
+//   - TIMER1_OVF (counter at BOTTOM): pin HIGH
+//   - first TIMER1_COMPB (counting up past OCR1B): pin LOW
+//   - second TIMER1_COMPB (counting down past OCR1B): pin HIGH
+// This mirrors the hardware non-inverting output, so duty = OCR1B / 255
+// at the same frequency as the red and green channels. The D9 fan PWM is untouched.
+//
+// COMPB has the higher priority, so when other interrupts delay both vectors
+// COMPB runs before OVF. A TOV1 flag still pending in COMPB means the counter
+// has passed BOTTOM and is counting up; TCNT1 then tells whether the up-count
+// match has happened yet. Duties above BLUE_SOFT_PWM_MAX are driven fully on,
+// because the two matches around TOP come less than ~64us apart and merge
+// into one interrupt whenever the ISR is delayed.
+#if defined(__AVR__) && defined(TIMER1_OVF_vect) && defined(TIMER1_COMPB_vect)
+#define RGBLED_SOFT_PWM 1
+#endif
+
+// Highest duty driven by software PWM: the matches around TOP are then at least
+// 2 * (255 - 247) ticks x 64 cycles = 1024 cycles apart. Anything above is within 3% of fully on.
+static const uint8_t BLUE_SOFT_PWM_MAX = 247;
+
+// Gamma correction table (gamma 2.8), maps perceptual brightness to PWM duty.
+static const uint8_t GAMMA8[256] PROGMEM = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      2,   3,   3,   3,   3,   3,   3,   3,   4,   4,   4,   4,   4,   5,   5,   5,
+      5,   6,   6,   6,   6,   7,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,
+     10,  10,  11,  11,  11,  12,  12,  13,  13,  13,  14,  14,  15,  15,  16,  16,
+     17,  17,  18,  18,  19,  19,  20,  20,  21,  21,  22,  22,  23,  24,  24,  25,
+     25,  26,  27,  27,  28,  29,  29,  30,  31,  32,  32,  33,  34,  35,  35,  36,
+     37,  38,  39,  39,  40,  41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  50,
+     51,  52,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  66,  67,  68,
+     69,  70,  72,  73,  74,  75,  77,  78,  79,  81,  82,  83,  85,  86,  87,  89,
+     90,  92,  93,  95,  96,  98,  99, 101, 102, 104, 105, 107, 109, 110, 112, 114,
+    115, 117, 119, 120, 122, 124, 126, 127, 129, 131, 133, 135, 137, 138, 140, 142,
+    144, 146, 148, 150, 152, 154, 156, 158, 160, 162, 164, 167, 169, 171, 173, 175,
+    177, 180, 182, 184, 186, 189, 191, 193, 196, 198, 200, 203, 205, 208, 210, 213,
+    215, 218, 220, 223, 225, 228, 231, 233, 236, 239, 241, 244, 247, 249, 252, 255,
+};
+
+static inline uint8_t gammaCorrect(uint8_t value) {
+    return pgm_read_byte(&GAMMA8[value]);
+}
+
+// Linear interpolation between two channel values
+static inline uint8_t lerp8(uint8_t from, uint8_t to, unsigned long elapsed, uint16_t duration) {
+    return (uint8_t)((long)from + ((long)to - (long)from) * (long)elapsed / (long)duration);
+}
+
+#ifdef RGBLED_SOFT_PWM
+// Interrupt-side state for the software PWM pin
+static volatile uint8_t* s_blueOut = 0;
+static uint8_t s_blueMask = 0;
+static volatile bool s_blueCountingDown = false;
+static volatile uint16_t s_pwmIsrCount = 0;
+
+ISR(TIMER1_OVF_vect) {
+    *s_blueOut |= s_blueMask;
+    s_blueCountingDown = false;
+    if (!(TIMSK1 & _BV(OCIE1B))) {
+        // First BOTTOM after enabling: start the compare interrupts in sync
+        TIFR1 = _BV(OCF1B);
+        TIMSK1 |= _BV(OCIE1B);
+    }
+    s_pwmIsrCount++;
+}
+
+ISR(TIMER1_COMPB_vect) {
+    if (TIFR1 & _BV(TOV1)) {
+        // BOTTOM passed but OVF not serviced yet: handle it here. Either this is
+        // the late down-count match of the previous period (counter still below
+        // OCR1B) or the up-count match already happened, possibly merged with it.
+        // (OCR1B reads the buffer, so a duty written since TOP can misjudge one period.)
+        if (TCNT1 < OCR1B) {
+            TIFR1 = _BV(TOV1);
+            *s_blueOut |= s_blueMask;
+            s_blueCountingDown = false;
+        } else {
+            TIFR1 = _BV(TOV1) | _BV(OCF1B); // This pass covers the up-count match too
+            *s_blueOut &= ~s_blueMask;
+            s_blueCountingDown = true;
+        }
+    } else if (s_blueCountingDown) {
+        *s_blueOut |= s_blueMask;
+    } else {
+        *s_blueOut &= ~s_blueMask;
+        s_blueCountingDown = true;
+    }
+    s_pwmIsrCount++;
+}
+#endif
+
 // Constructor implementation
 RGBLED::RGBLED(int redPin, int greenPin, int bluePin)
-    : _redPin(redPin), _greenPin(greenPin), _bluePin(bluePin) {
+    : _redPin(redPin), _greenPin(greenPin), _bluePin(bluePin), _blueSoftPwm(false),
+      _outRed(0), _outGreen(0), _outBlue(0), _outputsValid(false),
+      _animation(0), _animating(false), _frameIndex(0), _frameStart(0), _frameDuration(0),
+      _statsWindowStart(0), _busyMicros(0), _updateMicrosPerSecond(0), _pwmInterruptsPerSecond(0) {
     // Initialize the pin numbers for Red, Green, and Blue.
+    _animHeader.frames = 0;
+    _animHeader.frameCount = 0;
+    _animHeader.loop = false;
+    for (uint8_t i = 0; i < 3; i++) {
+        _from[i] = 0;
+        _to[i] = 0;
+    }
 }
 
 // begin() method implementation
@@ -11,6 +117,18 @@ void RGBLED::begin() {
     pinMode(_redPin, OUTPUT);
     pinMode(_greenPin, OUTPUT);
     pinMode(_bluePin, OUTPUT);
+
+#ifdef RGBLED_SOFT_PWM
+    // Only fall back to software PWM when the pin has no timer output
+    _blueSoftPwm = (digitalPinToTimer(_bluePin) == NOT_ON_TIMER);
+    if (_blueSoftPwm) {
+        s_blueOut = portOutputRegister(digitalPinToPort(_bluePin));
+        s_blueMask = digitalPinToBitMask(_bluePin);
+    }
+#endif
+
+    _outputsValid = false;
+    _statsWindowStart = millis();
     turnOff(); // Ensure the LED starts in an off state.
 }
 
@@ -20,16 +138,192 @@ void RGBLED::setColor(int r, int g, int b) {
     r = constrain(r, 0, 255);
     g = constrain(g, 0, 255);
     b = constrain(b, 0, 255);
-    
-    // Use PWM for red and green channels (PWM-capable pins)
-    analogWrite(_redPin, r);
-    analogWrite(_greenPin, g);
-    
-    // Use digital control for blue channel (non-PWM pin D8)
-    digitalWrite(_bluePin, b > 0 ? HIGH : LOW);
+
+    // A raw color overrides any running animation
+    stopAnimation();
+    _to[0] = r;
+    _to[1] = g;
+    _to[2] = b;
+
+    writeChannels(r, g, b);
 }
 
 // turnOff() method implementation
 void RGBLED::turnOff() {
     setColor(0, 0, 0); // Setting all colors to 0 effectively turns the LED off.
-}
\ No newline at end of file
+}
+
+// playAnimation() method implementation
+void RGBLED::playAnimation(const LEDAnimation* animation) {
+    if (animation == 0) {
+        stopAnimation();
+        return;
+    }
+    if (animation == _animation) {
+        return; // Already playing (or finished playing), don't restart it
+    }
+
+    memcpy_P(&_animHeader, animation, sizeof(LEDAnimation));
+    if (_animHeader.frameCount == 0) {
+        stopAnimation();
+        return;
+    }
+
+    _animation = animation;
+    _animating = true;
+    _frameStart = millis();
+    _frameDuration = 0;
+    loadFrame(0);
+    update(); // Show the first frame immediately
+}
+
+// stopAnimation() method implementation
+void RGBLED::stopAnimation() {
+    _animating = false;
+    _animation = 0;
+}
+
+// isAnimating() method implementation
+bool RGBLED::isAnimating() const {
+    return _animating;
+}
+
+// loadFrame() method implementation - the previous target becomes the new start color
+void RGBLED::loadFrame(uint8_t index) {
+    LEDKeyframe frame;
+    memcpy_P(&frame, &_animHeader.frames[index], sizeof(LEDKeyframe));
+
+    for (uint8_t i = 0; i < 3; i++) {
+        _from[i] = _to[i];
+    }
+    _to[0] = frame.r;
+    _to[1] = frame.g;
+    _to[2] = frame.b;
+    _frameDuration = frame.durationMs;
+    _frameIndex = index;
+}
+
+// advanceFrame() method implementation - returns false when a non-looping animation ends
+bool RGBLED::advanceFrame() {
+    uint8_t next = _frameIndex + 1;
+    if (next >= _animHeader.frameCount) {
+        if (!_animHeader.loop) {
+            return false;
+        }
+        next = 0;
+    }
+    _frameStart += _frameDuration;
+    loadFrame(next);
+    return true;
+}
+
+// update() method implementation - call this in main loop
+void RGBLED::update() {
+    unsigned long now = millis();
+
+    if (_animating) {
+        unsigned long startMicros = micros();
+
+        // Skip every keyframe that has already ended. Bounded so a loop of
+        // zero-length keyframes can't spin forever.
+        uint8_t steps = 0;
+        while (now - _frameStart >= _frameDuration) {
+            if (steps++ > _animHeader.frameCount || !advanceFrame()) {
+                break;
+            }
+        }
+
+        unsigned long elapsed = now - _frameStart;
+        uint8_t r, g, b;
+        if (elapsed < _frameDuration) {
+            r = lerp8(_from[0], _to[0], elapsed, _frameDuration);
+            g = lerp8(_from[1], _to[1], elapsed, _frameDuration);
+            b = lerp8(_from[2], _to[2], elapsed, _frameDuration);
+        } else {
+            // Keyframe done (end of a one-shot animation, or we fell behind)
+            r = _to[0];
+            g = _to[1];
+            b = _to[2];
+            if (!_animHeader.loop && _frameIndex + 1 >= _animHeader.frameCount) {
+                _animating = false;
+            } else {
+                _frameStart = now;
+            }
+        }
+
+        writeChannels(gammaCorrect(r), gammaCorrect(g), gammaCorrect(b));
+        _busyMicros += micros() - startMicros;
+    }
+
+    // Publish the usage figures once per second
+    if (now - _statsWindowStart >= 1000) {
+        _updateMicrosPerSecond = _busyMicros;
+        _busyMicros = 0;
+#ifdef RGBLED_SOFT_PWM
+        uint8_t oldSREG = SREG;
+        cli();
+        _pwmInterruptsPerSecond = s_pwmIsrCount;
+        s_pwmIsrCount = 0;
+        SREG = oldSREG;
+#endif
+        _statsWindowStart = now;
+    }
+}
+
+// getUpdateMicrosPerSecond() method implementation
+unsigned long RGBLED::getUpdateMicrosPerSecond() const {
+    return _updateMicrosPerSecond;
+}
+
+// getPwmInterruptsPerSecond() method implementation
+uint16_t RGBLED::getPwmInterruptsPerSecond() const {
+    return _pwmInterruptsPerSecond;
+}
+
+// writeChannels() method implementation - only touches channels that changed
+void RGBLED::writeChannels(uint8_t r, uint8_t g, uint8_t b) {
+    // Use PWM for red and green channels (PWM-capable pins)
+    if (!_outputsValid || r != _outRed) {
+        analogWrite(_redPin, r);
+        _outRed = r;
+    }
+    if (!_outputsValid || g != _outGreen) {
+        analogWrite(_greenPin, g);
+        _outGreen = g;
+    }
+    if (!_outputsValid || b != _outBlue) {
+        writeBlue(b);
+        _outBlue = b;
+    }
+    _outputsValid = true;
+}
+
+// writeBlue() method implementation
+void RGBLED::writeBlue(uint8_t value) {
+#ifdef RGBLED_SOFT_PWM
+    if (_blueSoftPwm) {
+        uint8_t oldSREG = SREG;
+        cli();
+        if (value == 0 || value > BLUE_SOFT_PWM_MAX) {
+            // Fully off/on needs no interrupts
+            TIMSK1 &= ~(_BV(TOIE1) | _BV(OCIE1B));
+            if (value == 0) {
+                *s_blueOut &= ~s_blueMask;
+            } else {
+                *s_blueOut |= s_blueMask;
+            }
+        } else {
+            OCR1B = value;
+            if (!(TIMSK1 & _BV(TOIE1))) {
+                // The OVF interrupt enables COMPB at the next BOTTOM, so the
+                // direction flag starts out in step with the counter
+                TIFR1 = _BV(TOV1);
+                TIMSK1 |= _BV(TOIE1);
+            }
+        }
+        SREG = oldSREG;
+        return;
+    }
+#endif
+    analogWrite(_bluePin, value);
+}
@@ -2,6 +2,7 @@
 #define RGB_LED_H
 
 #include <Arduino.h>
+#include "LEDAnimation.h"
 
 class RGBLED {
 public:
@@ -10,18 +11,71 @@ public:
     RGBLED(int redPin, int greenPin, int bluePin);
 
     // Initializes the LED pins as outputs.
+    // On AVR, a blue pin without hardware PWM (D8 on the Nano) is driven by
+    // software PWM from the Timer1 interrupts (duties above 247 are driven fully on).
+    // Only one RGBLED can own it.
     void begin();
 
     // Sets the color of the LED using RGB values (0-255 for each color).
+    // Values are written as-is (no gamma correction) and stop any running animation.
     void setColor(int r, int g, int b);
 
     // Convenience method to turn the LED off.
     void turnOff();
 
+    // Starts playing a keyframe animation stored in PROGMEM.
+    // The first keyframe fades from the current color. Calling this again with the
+    // animation that is already playing does nothing; use stopAnimation() to restart it.
+    void playAnimation(const LEDAnimation* animation);
+
+    // Stops the running animation, leaving the LED at its current color.
+    void stopAnimation();
+
+    // Returns true while an animation is running (false once a one-shot animation has finished).
+    bool isAnimating() const;
+
+    // Advances the running animation - call this in main loop for non-blocking operation.
+    void update();
+
+    // Time spent animating inside update() over the last full second, in microseconds.
+    unsigned long getUpdateMicrosPerSecond() const;
+
+    // Software PWM interrupts taken over the last full second (0 without software PWM).
+    // The cycles per interrupt come from the bench profile of __vector_12/__vector_13.
+    uint16_t getPwmInterruptsPerSecond() const;
+
 private:
     int _redPin;
     int _greenPin;
     int _bluePin;
+    bool _blueSoftPwm;             // Blue channel uses Timer1 software PWM
+
+    // Output cache (post-gamma) so unchanged channels are not rewritten every loop
+    uint8_t _outRed;
+    uint8_t _outGreen;
+    uint8_t _outBlue;
+    bool _outputsValid;
+
+    // Animation playback state
+    const LEDAnimation* _animation; // PROGMEM address of the playing animation
+    LEDAnimation _animHeader;       // SRAM copy of the animation descriptor
+    bool _animating;
+    uint8_t _frameIndex;
+    unsigned long _frameStart;      // millis() when the current keyframe started
+    uint16_t _frameDuration;
+    uint8_t _from[3];               // Perceptual color at the start of the keyframe
+    uint8_t _to[3];                 // Perceptual color at the end of the keyframe
+
+    // CPU usage accounting
+    unsigned long _statsWindowStart;
+    unsigned long _busyMicros;
+    unsigned long _updateMicrosPerSecond;
+    uint16_t _pwmInterruptsPerSecond;
+
+    void loadFrame(uint8_t index);
+    bool advanceFrame();
+    void writeChannels(uint8_t r, uint8_t g, uint8_t b);
+    void writeBlue(uint8_t value);
 };
 
-#endif // RGB_LED_H
\ No newline at end of file
+#endif // RGB_LED_H
@@ -6,6 +6,7 @@
 #include "Buzzer.h"
 #include "RGBLED.h"
 #include "IRRemote.h"
+#include "EventJournal.h"
 #include "DeviceStateMachine.h"
 
 // --- Pin Definitions ---
@@ -21,10 +22,10 @@ const int BUZZER_PIN = 3; // Using D3 for buzzer control
 
 // RGB LED Pins (connect via current-limiting resistors)
 // Red and Green pins are PWM-capable for variable brightness
-// Blue pin is digital only (on/off)
+// Blue pin has no hardware PWM; RGBLED drives it with Timer1 software PWM
 const int LED_RED_PIN   = 5; // Using D5 for Red LED (PWM)
 const int LED_GREEN_PIN = 6; // Using D6 for Green LED (PWM)
-const int LED_BLUE_PIN  = 8; // Using D8 for Blue LED (digital only)
+const int LED_BLUE_PIN  = 8; // Using D8 for Blue LED (software PWM)
 
 // IR Receiver Pin (TSOP1838)
 const int IR_RECEIVER_PIN = 4; // Using D4 for IR receiver
@@ -32,6 +33,11 @@ const int IR_RECEIVER_PIN = 4; // Using D4 for IR receiver
 // --- Device Behavior Parameters ---
 const unsigned long ACTIVATION_DURATION_MS = 5000; // How long the fan/buzzer stays on (5 seconds)
 const int FAN_SPEED_ACTIVATED = 255; // Fan speed when activated (0-255, 255 is full speed)
+const int JOURNAL_EEPROM_START = 0;    // Event journal uses the EEPROM from this address...
+const int JOURNAL_EEPROM_SIZE = 1024;  // ...for this many bytes (whole 1KB EEPROM on the Nano, 128 records)
+const unsigned long LED_STATS_INTERVAL_MS = 30000; // How often to report the LED CPU figures (30 seconds)
+
+unsigned long lastLedStatsReport = 0;
 
 // --- Object Instantiation ---
 // Create instances of our component classes
@@ -40,9 +46,10 @@ PWMFan myFan(FAN_PWM_PIN);
 Buzzer myBuzzer(BUZZER_PIN);
 RGBLED myLED(LED_RED_PIN, LED_GREEN_PIN, LED_BLUE_PIN);
 IRRemote myIRRemote(IR_RECEIVER_PIN);
+EventJournal myJournal(JOURNAL_EEPROM_START, JOURNAL_EEPROM_SIZE);
 
 // Create state machine instance
-DeviceStateMachine stateMachine(myPIR, myFan, myBuzzer, myLED, myIRRemote, 
+DeviceStateMachine stateMachine(myPIR, myFan, myBuzzer, myLED, myIRRemote, myJournal,
                                 ACTIVATION_DURATION_MS, FAN_SPEED_ACTIVATED);
 
 void setup() {
@@ -56,7 +63,7 @@ void setup() {
   myBuzzer.begin();
   myLED.begin();
   myIRRemote.begin();
-  stateMachine.begin();
+  myJournal.begin();
 
   // LED Test - cycle through colors
   Serial.println("Testing LED colors...");
@@ -80,6 +87,9 @@ void setup() {
   Serial.println("ALL LEDS OFF");
   delay(2000);
 
+  // Start the state machine after the LED test so it owns the LED from here on
+  stateMachine.begin();
+
   Serial.println("PIR sensor warming up...");
   Serial.println("Device ready.");
 }
@@ -92,5 +102,29 @@ void loop() {
   
   // Update state machine
   stateMachine.update();
+
+  // Write queued journal records and stream a requested dump
+  myJournal.update();
+
+  // Serial query: 'J' starts streaming the event journal (printed by myJournal.update())
+  if (Serial.available()) {
+    char command = Serial.read();
+    if (command == 'J' || command == 'j') {
+      myJournal.dump(Serial);
+    }
+  }
+
+  // Play the LED animation selected by the state machine
+  myLED.update();
+
+  // Periodically report how much CPU the LED animation costs
+  if (millis() - lastLedStatsReport >= LED_STATS_INTERVAL_MS) {
+    lastLedStatsReport = millis();
+    Serial.print("LED update: ");
+    Serial.print(myLED.getUpdateMicrosPerSecond());
+    Serial.print(" us/s, blue PWM interrupts: ");
+    Serial.print(myLED.getPwmInterruptsPerSecond());
+    Serial.println("/s");
+  }
 }
 
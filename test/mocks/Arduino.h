@@ -0,0 +1,71 @@
+#ifndef MOCK_ARDUINO_H
+#define MOCK_ARDUINO_H
+
+// Minimal Arduino API for native unit tests (pio test -e native).
+// State lives in function-local statics so every translation unit shares it.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+// Controllable millis()
+inline unsigned long& mockMillisValue() {
+    static unsigned long value = 0;
+    return value;
+}
+
+inline unsigned long millis() {
+    return mockMillisValue();
+}
+
+inline void mockSetMillis(unsigned long ms) {
+    mockMillisValue() = ms;
+}
+
+// Print that captures its output in a string
+class Print {
+public:
+    Print() : writeRoom(64) {}
+    virtual ~Print() {}
+
+    // Free space reported to callers that avoid blocking on a full TX buffer
+    virtual int availableForWrite() { return writeRoom; }
+
+    void print(const char* s) { output += s; }
+    void print(char c) { output += c; }
+    void print(int v) { printNumber("%d", v); }
+    void print(unsigned int v) { printNumber("%u", v); }
+    void print(long v) { printNumber("%ld", v); }
+    void print(unsigned long v) { printNumber("%lu", v); }
+
+    void println() { output += "\r\n"; }
+    template <typename T> void println(T v) {
+        print(v);
+        println();
+    }
+
+    std::string output;
+    int writeRoom;
+
+private:
+    template <typename T> void printNumber(const char* format, T v) {
+        char buffer[24];
+        snprintf(buffer, sizeof(buffer), format, v);
+        output += buffer;
+    }
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    int available() { return 0; }
+    int read() { return -1; }
+};
+
+inline HardwareSerial& mockSerial() {
+    static HardwareSerial serial;
+    return serial;
+}
+#define Serial mockSerial()
+
+#endif // MOCK_ARDUINO_H
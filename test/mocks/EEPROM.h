@@ -0,0 +1,48 @@
+#ifndef MOCK_EEPROM_H
+#define MOCK_EEPROM_H
+
+// RAM-backed EEPROM for native unit tests. Starts erased (0xFF) like real EEPROM.
+
+#include <stdint.h>
+#include <string.h>
+
+class MockEEPROM {
+public:
+    static const int SIZE = 1024;
+
+    MockEEPROM() : commits(0) { clear(); }
+
+    void begin(int) {}
+    uint8_t read(int address) { return data[address]; }
+    void write(int address, uint8_t value) { data[address] = value; }
+    void update(int address, uint8_t value) { data[address] = value; }
+    void commit() { commits++; }
+    int length() { return SIZE; }
+
+    template <typename T> T& get(int address, T& t) {
+        memcpy(&t, data + address, sizeof(T));
+        return t;
+    }
+
+    template <typename T> const T& put(int address, const T& t) {
+        memcpy(data + address, &t, sizeof(T));
+        return t;
+    }
+
+    // Erases everything, as on a factory-new chip
+    void clear() {
+        memset(data, 0xFF, sizeof(data));
+        commits = 0;
+    }
+
+    uint8_t data[SIZE];
+    int commits;
+};
+
+inline MockEEPROM& mockEEPROM() {
+    static MockEEPROM eeprom;
+    return eeprom;
+}
+#define EEPROM mockEEPROM()
+
+#endif // MOCK_EEPROM_H
@@ -0,0 +1,259 @@
+#include <unity.h>
+#include <stdlib.h>
+#include <vector>
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "EventJournal.h"
+
+// Small log so tests can wrap it many times
+static const int SLOTS = 16;
+static const int LOG_BYTES = SLOTS * sizeof(JournalRecord);
+
+// Parsed output of one dump
+struct DumpResult {
+    int announced;                 // Count from the JOURNAL BEGIN line
+    bool ended;                    // JOURNAL END was printed
+    std::vector<uint16_t> seqs;    // Sequence numbers, in dump order
+    std::vector<std::string> events;
+};
+
+// Runs a dump to completion and parses it
+static DumpResult runDump(EventJournal& journal) {
+    Print out;
+    journal.dump(out);
+    for (int i = 0; i < 1000 && journal.isDumping(); i++) {
+        journal.update();
+    }
+
+    DumpResult result = {-1, false, std::vector<uint16_t>(), std::vector<std::string>()};
+    size_t pos = 0;
+    while (pos < out.output.size()) {
+        size_t end = out.output.find("\r\n", pos);
+        std::string line = out.output.substr(pos, end - pos);
+        pos = end + 2;
+
+        unsigned seq, delta, duration;
+        char event[16];
+        if (line.compare(0, 14, "JOURNAL BEGIN ") == 0) {
+            result.announced = atoi(line.c_str() + 14);
+        } else if (line == "JOURNAL END") {
+            result.ended = true;
+        } else if (sscanf(line.c_str(), "%u,%15[^,],%u,%u", &seq, event, &delta, &duration) == 4) {
+            result.seqs.push_back((uint16_t)seq);
+            result.events.push_back(event);
+        }
+    }
+    return result;
+}
+
+// Boots a journal (logging BOOT) and stores count more ACTIVATION records
+static void bootAndLog(int count) {
+    EventJournal journal(0, LOG_BYTES);
+    journal.begin();
+    for (int i = 0; i < count; i++) {
+        journal.logEvent(JOURNAL_ACTIVATION, 1);
+    }
+    journal.flush();
+}
+
+// Checks that seqs run consecutively (mod 65536) and end at last
+static void assertConsecutive(const std::vector<uint16_t>& seqs, uint16_t last) {
+    TEST_ASSERT_TRUE(seqs.size() > 0);
+    TEST_ASSERT_EQUAL_UINT16(last, seqs.back());
+    for (size_t i = 1; i < seqs.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT16((uint16_t)(seqs[i - 1] + 1), seqs[i]);
+    }
+}
+
+// Overwrites the first bytes of a slot, as a write cut off by a power loss would
+static void tearSlot(int slot, uint16_t seq) {
+    EEPROM.write(slot * sizeof(JournalRecord), seq & 0xFF);
+    EEPROM.write(slot * sizeof(JournalRecord) + 1, seq >> 8);
+    EEPROM.write(slot * sizeof(JournalRecord) + 2, JOURNAL_ACTIVATION);
+}
+
+void setUp(void) {
+    EEPROM.clear();
+    mockSetMillis(0);
+}
+
+void tearDown(void) {
+}
+
+void test_EventJournal_begin_blank_eeprom(void) {
+    EventJournal journal(0, LOG_BYTES);
+    journal.begin();
+
+    // Only the BOOT record, still pending in RAM
+    TEST_ASSERT_EQUAL(1, journal.getRecordCount());
+    DumpResult dump = runDump(journal);
+    TEST_ASSERT_EQUAL(1, dump.announced);
+    TEST_ASSERT_TRUE(dump.ended);
+    TEST_ASSERT_EQUAL(1, dump.seqs.size());
+    TEST_ASSERT_EQUAL_UINT16(0, dump.seqs[0]);
+    TEST_ASSERT_EQUAL_STRING("BOOT", dump.events[0].c_str());
+}
+
+void test_EventJournal_records_survive_reboot(void) {
+    bootAndLog(5);
+
+    EventJournal journal(0, LOG_BYTES);
+    journal.begin();
+    TEST_ASSERT_EQUAL(7, journal.getRecordCount());
+    DumpResult dump = runDump(journal);
+    assertConsecutive(dump.seqs, 6);
+    TEST_ASSERT_EQUAL(7, dump.seqs.size());
+    TEST_ASSERT_EQUAL_STRING("ACTIVATION", dump.events[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("BOOT", dump.events[6].c_str());
+}
+
+void test_EventJournal_recovery_at_every_head_position(void) {
+    // Cover the blank, exactly full and wrapped cases at every write position
+    for (int written = 1; written <= 3 * SLOTS + 1; written++) {
+        EEPROM.clear();
+        bootAndLog(written - 1); // BOOT + written - 1 records
+
+        EventJournal journal(0, LOG_BYTES);
+        journal.begin();
+        int stored = written < SLOTS ? written : SLOTS;
+        TEST_ASSERT_EQUAL(stored + 1, journal.getRecordCount());
+
+        DumpResult dump = runDump(journal);
+        TEST_ASSERT_EQUAL(stored + 1, dump.seqs.size());
+        assertConsecutive(dump.seqs, (uint16_t)written);
+    }
+}
+
+void test_EventJournal_torn_slot_at_head(void) {
+    // A write cut off at the head slot, both before and after the log wrapped
+    for (int written = 2; written <= 3 * SLOTS; written++) {
+        EEPROM.clear();
+        bootAndLog(written - 1);
+        int head = written % SLOTS;
+        tearSlot(head, (uint16_t)written);
+
+        EventJournal journal(0, LOG_BYTES);
+        journal.begin();
+        DumpResult dump = runDump(journal);
+
+        // Numbering continues after the newest intact record
+        assertConsecutive(dump.seqs, (uint16_t)written);
+        if (written < SLOTS) {
+            TEST_ASSERT_EQUAL(written + 1, dump.seqs.size());
+        } else {
+            // The torn slot held the oldest record of the previous lap
+            TEST_ASSERT_EQUAL(SLOTS, dump.seqs.size());
+        }
+    }
+}
+
+void test_EventJournal_torn_slot_is_overwritten(void) {
+    bootAndLog(SLOTS + 3);
+    tearSlot((SLOTS + 4) % SLOTS, SLOTS + 4);
+
+    // The next boot writes its records over the torn slot
+    bootAndLog(2);
+
+    EventJournal journal(0, LOG_BYTES);
+    journal.begin();
+    DumpResult dump = runDump(journal);
+    TEST_ASSERT_EQUAL(SLOTS + 1, dump.seqs.size());
+    assertConsecutive(dump.seqs, SLOTS + 7);
+}
+
+void test_EventJournal_sequence_wraps_at_65535(void) {
+    // Run the sequence number up to just below the wrap in one boot
+    bootAndLog(65530 - 1);
+
+    // Reboot at every position across 65535 -> 0
+    uint16_t next = 65530;
+    for (int boot = 0; boot < SLOTS + 4; boot++) {
+        EventJournal journal(0, LOG_BYTES);
+        journal.begin();
+        DumpResult dump = runDump(journal);
+        TEST_ASSERT_EQUAL(SLOTS + 1, dump.seqs.size());
+        assertConsecutive(dump.seqs, next);
+        journal.flush();
+        next++;
+    }
+    TEST_ASSERT_EQUAL_UINT16(14, next); // Crossed the wrap
+}
+
+void test_EventJournal_dump_waits_for_output_room(void) {
+    bootAndLog(3);
+    EventJournal journal(0, LOG_BYTES);
+    journal.begin();
+
+    Print out;
+    out.writeRoom = JOURNAL_DUMP_LINE_BYTES - 1;
+    journal.dump(out);
+    for (int i = 0; i < 10; i++) {
+        journal.update();
+    }
+    TEST_ASSERT_TRUE(out.output.empty());
+    TEST_ASSERT_TRUE(journal.isDumping());
+
+    // One line per update() once there is room
+    out.writeRoom = JOURNAL_DUMP_LINE_BYTES;
+    journal.update();
+    TEST_ASSERT_EQUAL_STRING("JOURNAL BEGIN 5\r\n", out.output.c_str());
+    for (int i = 0; i < 10 && journal.isDumping(); i++) {
+        journal.update();
+    }
+    TEST_ASSERT_FALSE(journal.isDumping());
+}
+
+void test_EventJournal_dump_excludes_later_records(void) {
+    bootAndLog(3);
+    EventJournal journal(0, LOG_BYTES);
+    journal.begin();
+
+    Print out;
+    journal.dump(out);
+    journal.update(); // BEGIN line
+    journal.logEvent(JOURNAL_IR_DISABLE);
+    journal.flush();
+
+    // A second request while dumping is ignored
+    Print other;
+    journal.dump(other);
+    for (int i = 0; i < 20 && journal.isDumping(); i++) {
+        journal.update();
+    }
+    TEST_ASSERT_TRUE(other.output.empty());
+    TEST_ASSERT_TRUE(out.output.find("IR_DISABLE") == std::string::npos);
+    TEST_ASSERT_TRUE(out.output.find("JOURNAL END") != std::string::npos);
+
+    // The next dump includes it
+    DumpResult dump = runDump(journal);
+    TEST_ASSERT_EQUAL(6, dump.seqs.size());
+    TEST_ASSERT_EQUAL_STRING("IR_DISABLE", dump.events.back().c_str());
+}
+
+void test_EventJournal_delta_seconds(void) {
+    EventJournal journal(0, LOG_BYTES);
+    journal.begin();
+    mockSetMillis(90500);
+    journal.logEvent(JOURNAL_ACTIVATION, 12);
+
+    Print out;
+    journal.dump(out);
+    while (journal.isDumping()) {
+        journal.update();
+    }
+    TEST_ASSERT_TRUE(out.output.find("1,ACTIVATION,90,12\r\n") != std::string::npos);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_EventJournal_begin_blank_eeprom);
+    RUN_TEST(test_EventJournal_records_survive_reboot);
+    RUN_TEST(test_EventJournal_recovery_at_every_head_position);
+    RUN_TEST(test_EventJournal_torn_slot_at_head);
+    RUN_TEST(test_EventJournal_torn_slot_is_overwritten);
+    RUN_TEST(test_EventJournal_sequence_wraps_at_65535);
+    RUN_TEST(test_EventJournal_dump_waits_for_output_room);
+    RUN_TEST(test_EventJournal_dump_excludes_later_records);
+    RUN_TEST(test_EventJournal_delta_seconds);
+    return UNITY_END();
+}